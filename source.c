@@ -4,10 +4,10 @@
  * @date 2023-10-03
  * @details Este trabalho consiste na leitura de um ficheiro com dados sobre antenas de telecomunicações e a sua 
  * representação em memória através de listas ligadas. O programa permite a leitura do ficheiro, a impressão do mapa das antenas, 
- * a procura em profundidade e largura e a interseção de antenas.
+ * a procura em profundidade e largura, o caminho mais curto entre antenas e a interseção de antenas. Mapas demasiado grandes para a memória podem ser
+ * analisados por faixas de linhas, com os registos das antenas guardados em ficheiros temporários.
  * @bug nas interseções não é validado se a interseção acontece apenas no segmento de reta entre as antenas 
  * ou se se interseccionam fora do segmento de reta. No entanto é validado se essa interseção acontece dentro do mapa.
- * @bug a função de traçar caminhos ainda não está implementada.
  * @
  */
 
@@ -31,6 +31,15 @@
 
 #define TAM 50
 
+/**
+ * @brief Posicionamento nos ficheiros temporários com deslocamentos de 64 bits (no Windows o long tem 32 bits).
+ */
+#ifdef _WIN32
+#define fseek64(ficheiro, posicao, origem) _fseeki64(ficheiro, (long long)(posicao), origem)
+#else
+#define fseek64(ficheiro, posicao, origem) fseeko(ficheiro, (off_t)(posicao), origem)
+#endif
+
 /**
  * @brief Definição da estrutura de dados para as antenas.
  */
@@ -53,16 +62,90 @@ typedef struct adjacentes
     struct adjacentes* seguinte;
 } *adjacentes;
 
+/**
+ * @brief Definição da estrutura de dados das antenas organizada por colunas.
+ * @details Cada campo da antena fica num vetor contíguo próprio e as antenas estão ordenadas por frequência
+ * (e, dentro de cada frequência, pelo número do vértice). As antenas da frequência f ocupam as posições
+ * [inicio[f], inicio[f + 1]), o que torna os ciclos por frequência lineares e sem seguir ponteiros.
+ * A frequência não tem vetor próprio: é dada pelo intervalo em que a posição está.
+ */
+typedef struct colunasantenas
+{
+    int total;                                  /// Número de antenas
+    int* linha;
+    int* coluna;
+    int* vertice;
+    int* indice;                                /// Posição de cada vértice nos vetores (indice[vertice])
+    int inicio[257];                            /// Início de cada frequência nos vetores
+} *colunasantenas;
+
+/**
+ * @brief Definição do registo de uma antena nos ficheiros temporários da análise por faixas.
+ */
+typedef struct registoantena
+{
+    char freq;
+    int linha;
+    int coluna;
+    long long vertice;
+} registoantena;
+
+/**
+ * @brief Definição do resumo de uma frequência na análise por faixas.
+ * @details É a única informação das antenas que fica em memória: quantas são, o retângulo que ocupam no mapa
+ * e a posição do primeiro registo no ficheiro temporário agrupado por frequência.
+ */
+typedef struct resumofrequencia
+{
+    long long quantidade;
+    int linhamin;
+    int linhamax;
+    int colunamin;
+    int colunamax;
+    long long inicio;
+} resumofrequencia;
+
+/**
+ * @brief Definição da estrutura de dados com o estado da última leitura do ficheiro.
+ * @details Guarda as dimensões do mapa e um hash do conteúdo de cada linha, para que uma nova leitura
+ * só tenha de voltar a interpretar as linhas que foram alteradas.
+ */
+typedef struct estadoleitura
+{
+    int linhas;
+    int colunas;
+    unsigned long* hashlinhas;                  /// Hash de cada linha do mapa (por ordem)
+} *estadoleitura;
+
 /**
  * @brief Definição da estrutura de dados para o caminho.
- * @details Esta estrutura contém um ponteiro para o próximo adjacente e o número do vértice adjacente.
+ * @details Esta estrutura contém um ponteiro para o próximo vértice do caminho e o número do vértice.
  */
-// typedef struct caminho
-// {
-//     int vertice;
-//     int verticeadjacente;
-//     struct caminho* seguinte;
-// } *caminho;
+typedef struct caminho
+{
+    int vertice;
+    struct caminho* seguinte;
+} *caminho;
+
+/**
+ * @brief Definição de um elemento da heap usada na procura do caminho mais curto.
+ */
+typedef struct elementoheap
+{
+    float prioridade;                           /// Distância percorrida mais a estimativa até ao destino
+    int vertice;
+} elementoheap;
+
+/**
+ * @brief Definição da heap de 4 filhos usada na procura do caminho mais curto.
+ * @details Os elementos estão num único vetor e os filhos da posição i ocupam as posições 4i+1 a 4i+4.
+ */
+typedef struct heapcaminho
+{
+    elementoheap* elementos;
+    int tamanho;
+    int capacidade;
+} *heapcaminho;
 
 /**
  * @brief Função para contar o número de antenas válidas na lista.
@@ -184,13 +267,51 @@ int n_linhas(char ficheiro[])
     return (linhas + 1); /// Adiciona 1 para contar a última linha
 }
 
+/**
+ * @brief Função para calcular o hash do conteúdo de uma linha do mapa (FNV-1a).
+ * @param linha Caracteres da linha.
+ * @param colunas Número de colunas da linha.
+ * @return Hash da linha.
+ */
+unsigned long hash_linha(char linha[], int colunas)
+{
+    unsigned long hash = 2166136261UL;
+    for (int j = 0; j < colunas; j++)
+    {
+        hash ^= (unsigned char)linha[j];
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL; /// Mantém o hash em 32 bits em qualquer plataforma
+    }
+    return hash;
+}
+
+/**
+ * @brief Função para ler uma linha do mapa a partir do ficheiro.
+ * @details Ignora espaços e mudanças de linha (como o " %c" do fscanf), para que a leitura completa e a
+ * leitura incremental vejam as mesmas linhas. Se o ficheiro terminar antes, a linha é completada com '.'.
+ * @param cidade Ponteiro para o ficheiro aberto.
+ * @param linha Vetor onde são guardados os caracteres.
+ * @param colunas Número de colunas a ler.
+ */
+void ler_linha_mapa(FILE *cidade, char linha[], int colunas)
+{
+    int c;
+    for (int j = 0; j < colunas; j++)
+    {
+        while ((c = fgetc(cidade)) != EOF && isspace(c));
+        linha[j] = (c == EOF) ? '.' : (char)c;
+    }
+}
+
 /**
  * @brief Função para ler o ficheiro e armazenar os dados na lista de antenas.
+ * @details Se for indicado um estado, guarda nele as dimensões e o hash de cada linha lida, calculados sobre as
+ * mesmas linhas que dão origem às antenas, para servir de base a recarregar_ficheiro.
  * @param cidade Ponteiro para o ficheiro.
  * @param mapa Ponteiro para a lista de antenas.
+ * @param estado Estado da leitura a preencher (pode ser NULL).
  * @return Ponteiro para a lista de antenas.
  */
-antenas ler_ficheiro(char ficheiro[], antenas mapa)
+antenas ler_ficheiro(char ficheiro[], antenas mapa, estadoleitura estado)
 
 {
     FILE *cidade = fopen(ficheiro, "rb");
@@ -205,16 +326,24 @@ antenas ler_ficheiro(char ficheiro[], antenas mapa)
     int linha = n_linhas(ficheiro);
     int coluna = n_colunas(ficheiro);
     char matriz[linha][coluna];
+    unsigned long *hashlinhas = estado ? (unsigned long*)malloc(linha * sizeof(unsigned long)) : NULL;
 
     for (int i = 0; i < linha; i++)
     {
-        for (int j = 0; j < coluna; j++)
-        {
-            fscanf(cidade, " %c", &matriz[i][j]);
-        }
+        ler_linha_mapa(cidade, matriz[i], coluna);
+        if (hashlinhas)
+            hashlinhas[i] = hash_linha(matriz[i], coluna);
     }
     fclose(cidade);
 
+    if (estado) /// Sem hashes o estado fica vazio e a próxima recarga faz uma leitura completa
+    {
+        free(estado->hashlinhas);
+        estado->hashlinhas = hashlinhas;
+        estado->linhas = hashlinhas ? linha : 0;
+        estado->colunas = hashlinhas ? coluna : 0;
+    }
+
     for (int i = 0; i < linha; i++)
     {
         for (int j = 0; j < coluna; j++)
@@ -225,6 +354,11 @@ antenas ler_ficheiro(char ficheiro[], antenas mapa)
                 corletra(RED);
                 printf("Erro ao alocar memória.\n");
                 corletra(WHITE);
+                if (estado) /// A lista ficou incompleta, por isso a próxima recarga tem de ler tudo
+                {
+                    estado->linhas = 0;
+                    estado->colunas = 0;
+                }
                 return mapa;
             }
 
@@ -266,6 +400,96 @@ antenas ler_ficheiro(char ficheiro[], antenas mapa)
     return mapa;
 }
 
+/**
+ * @brief Função para construir a organização por colunas a partir da lista de antenas.
+ * @details Usa uma ordenação por contagem pela frequência, que é estável e por isso mantém a ordem dos vértices
+ * dentro de cada frequência.
+ * @param mapa Ponteiro para a lista de antenas.
+ * @return Ponteiro para as colunas ou NULL em caso de erro.
+ */
+colunasantenas construir_colunas(antenas mapa)
+{
+    colunasantenas colunas = (colunasantenas)calloc(1, sizeof(struct colunasantenas));
+    if (!colunas)
+        return NULL;
+
+    int contagem[256] = {0};
+    for (antenas a = mapa; a != NULL; a = a->seguinte)
+    {
+        contagem[(unsigned char)a->freq]++;
+        colunas->total++;
+    }
+
+    int n = colunas->total > 0 ? colunas->total : 1;
+    colunas->linha = (int*)malloc(n * sizeof(int));
+    colunas->coluna = (int*)malloc(n * sizeof(int));
+    colunas->vertice = (int*)malloc(n * sizeof(int));
+    colunas->indice = (int*)malloc((n + 1) * sizeof(int));
+    if (!colunas->linha || !colunas->coluna || !colunas->vertice || !colunas->indice)
+    {
+        free(colunas->linha);
+        free(colunas->coluna);
+        free(colunas->vertice);
+        free(colunas->indice);
+        free(colunas);
+        return NULL;
+    }
+
+    int posicao[256];
+    colunas->inicio[0] = 0;
+    for (int f = 0; f < 256; f++)
+    {
+        posicao[f] = colunas->inicio[f];
+        colunas->inicio[f + 1] = colunas->inicio[f] + contagem[f];
+    }
+
+    for (antenas a = mapa; a != NULL; a = a->seguinte)
+    {
+        int i = posicao[(unsigned char)a->freq]++;
+        colunas->linha[i] = a->coordenadas / 1000;
+        colunas->coluna[i] = a->coordenadas % 1000;
+        colunas->vertice[i] = a->verticeantena;
+        colunas->indice[a->verticeantena] = i;
+    }
+    return colunas;
+}
+
+/**
+ * @brief Função para libertar a memória alocada para as colunas das antenas.
+ * 
+ * @param colunas 
+ */
+void libertar_colunas(colunasantenas colunas)
+{
+    if (colunas == NULL)
+        return;
+    free(colunas->linha);
+    free(colunas->coluna);
+    free(colunas->vertice);
+    free(colunas->indice);
+    free(colunas);
+}
+
+/**
+ * @brief Função para saber a frequência das antenas numa posição das colunas.
+ * @param colunas Antenas organizadas por colunas.
+ * @param posicao Posição nos vetores.
+ * @return Frequência f tal que inicio[f] <= posicao < inicio[f + 1].
+ */
+int frequencia_da_posicao(colunasantenas colunas, int posicao)
+{
+    int baixo = 1, alto = 256;
+    while (baixo < alto) /// Pesquisa binária pelo primeiro inicio[k] maior que a posição
+    {
+        int meio = (baixo + alto) / 2;
+        if (colunas->inicio[meio] <= posicao)
+            baixo = meio + 1;
+        else
+            alto = meio;
+    }
+    return baixo - 1;
+}
+
 /**
 * @brief Função para imprimir o mapa das antenas.
 * @param ficheiro Nome do ficheiro.
@@ -426,70 +650,321 @@ void procuraLargura(antenas mapa, int vertice) {
     }
 }
 
-// LL PARA GUARDAR OS CAMINHOS
-//COMEÇO NUM VERTICE, GUARDO ESSE VERTICE NA LISTA CAMINHO, DEPOIS VOU AOS ADJACENTES E GUARDO O PROXIMO NO CAMINHO, 
-//DEPOIS VOU AOS ADJACENTES DO PROXIMO E GUARDO O PROXIMO NO CAMINHO, ASSIM SUCESSIVAMENTE. 
+/**
+ * @brief Função para libertar a memória alocada para um caminho.
+ * 
+ * @param lista 
+ */
+void libertar_caminho(caminho lista)
+{
+    while (lista != NULL) {
+        caminho temp = lista;
+        lista = lista->seguinte;
+        free(temp);
+    }
+}
+
+/**
+ * @brief Função para inserir um elemento na heap de 4 filhos.
+ * @param heap Heap de prioridades.
+ * @param prioridade Distância percorrida mais a estimativa até ao destino.
+ * @param vertice Número do vértice.
+ * @return 1 se foi inserido, 0 em caso de erro de memória.
+ */
+int heap_inserir(heapcaminho heap, float prioridade, int vertice)
+{
+    if (heap->tamanho == heap->capacidade) {
+        int capacidade = heap->capacidade > 0 ? heap->capacidade * 2 : 16;
+        elementoheap *elementos = (elementoheap*)realloc(heap->elementos, capacidade * sizeof(elementoheap));
+        if (!elementos)
+            return 0;
+        heap->elementos = elementos;
+        heap->capacidade = capacidade;
+    }
 
-// void caminho_a_para_b(antenas mapa, int inicio, int fim){
-//     antenas aux = mapa;
-//     adjacentes adj = NULL;
-//     int visitados[contarantenas(mapa)];
-//     while (aux != NULL) {
-//         if (aux->verticeantena == inicio) {
-//             adj = aux->listaadjacentes;
-//         }
-//         aux = aux->seguinte;
-//     }
-//     int n_antenas = contaradj(adj);
-//     caminho circuito = (caminho)malloc(sizeof(struct adjacentes));
-//     circuito->verticeadjacente = inicio;
-//     circuito->seguinte = NULL;
-// }
+    int i = heap->tamanho++;
+    while (i > 0) { /// Sobe enquanto o pai tiver maior prioridade
+        int pai = (i - 1) / 4;
+        if (heap->elementos[pai].prioridade <= prioridade)
+            break;
+        heap->elementos[i] = heap->elementos[pai];
+        i = pai;
+    }
+    heap->elementos[i].prioridade = prioridade;
+    heap->elementos[i].vertice = vertice;
+    return 1;
+}
+
+/**
+ * @brief Função para remover o elemento com menor prioridade da heap de 4 filhos.
+ * @details Os 4 filhos de cada posição estão seguidos no vetor, o que torna a descida mais curta e amiga da cache
+ * do que numa heap binária.
+ * @param heap Heap de prioridades (não vazia).
+ * @return Elemento removido.
+ */
+elementoheap heap_remover_minimo(heapcaminho heap)
+{
+    elementoheap minimo = heap->elementos[0];
+    elementoheap ultimo = heap->elementos[--heap->tamanho];
+    int i = 0;
+    while (1) { /// Desce enquanto algum filho tiver menor prioridade
+        int primeiro = 4 * i + 1;
+        if (primeiro >= heap->tamanho)
+            break;
+        int menor = primeiro;
+        int fim = primeiro + 4 < heap->tamanho ? primeiro + 4 : heap->tamanho;
+        for (int filho = primeiro + 1; filho < fim; filho++) {
+            if (heap->elementos[filho].prioridade < heap->elementos[menor].prioridade)
+                menor = filho;
+        }
+        if (heap->elementos[menor].prioridade >= ultimo.prioridade)
+            break;
+        heap->elementos[i] = heap->elementos[menor];
+        i = menor;
+    }
+    if (heap->tamanho > 0)
+        heap->elementos[i] = ultimo;
+    return minimo;
+}
+
+/**
+ * @brief Função para calcular a distância em linha reta entre duas posições do mapa.
+ * @param linha1, coluna1 Coordenadas da primeira posição.
+ * @param linha2, coluna2 Coordenadas da segunda posição.
+ * @return Distância euclidiana.
+ */
+float distancia_coordenadas(int linha1, int coluna1, int linha2, int coluna2)
+{
+    float linhas = (float)(linha1 - linha2);
+    float colunas = (float)(coluna1 - coluna2);
+    return sqrtf(linhas * linhas + colunas * colunas);
+}
+
+/**
+ * @brief Função para encontrar o caminho fisicamente mais curto entre duas antenas (A*).
+ * @details O custo de cada ligação é a distância euclidiana entre as coordenadas das antenas ligadas e a estimativa
+ * é a distância em linha reta até ao destino, que nunca é maior do que o custo real, por isso o caminho encontrado é
+ * o mais curto. Os adjacentes de uma antena são as restantes antenas da sua frequência (as mesmas que
+ * adicionarAdjacentes liga), por isso a procura fica dentro do intervalo dessa frequência nas colunas e lê
+ * linha[] e coluna[] diretamente. Os vértices por expandir ficam numa heap de 4 filhos; em vez de atualizar
+ * prioridades, é inserida uma nova entrada e as entradas antigas são ignoradas quando saem da heap.
+ * @param colunas Antenas organizadas por colunas.
+ * @param inicio Vértice de partida.
+ * @param fim Vértice de chegada.
+ * @param distanciamaxima Distância máxima de cada ligação (0 ou negativa para não haver limite).
+ * @param percurso Caminho de inicio até fim, ou NULL se não existir.
+ * @param distanciatotal Comprimento total do caminho encontrado.
+ * @return 1 se a procura terminou (com ou sem caminho), 0 em caso de erro de memória.
+ */
+int caminho_mais_curto(colunasantenas colunas, int inicio, int fim, float distanciamaxima, caminho *percurso, float *distanciatotal)
+{
+    *percurso = NULL;
+    *distanciatotal = 0;
+    if (colunas == NULL || inicio < 1 || inicio > colunas->total || fim < 1 || fim > colunas->total)
+        return 1;
+
+    int f = frequencia_da_posicao(colunas, colunas->indice[inicio]);
+    int primeiro = colunas->inicio[f];
+    int n = colunas->inicio[f + 1] - primeiro;                     /// Antenas da frequência de partida
+    int origem = colunas->indice[inicio] - primeiro;
+    int destino = colunas->indice[fim] - primeiro;
+    if (destino < 0 || destino >= n)                                /// Frequências diferentes nunca estão ligadas
+        return 1;
+
+    int *linha = colunas->linha + primeiro;
+    int *coluna = colunas->coluna + primeiro;
+    float *percorrida = (float*)malloc(n * sizeof(float));         /// Menor distância conhecida desde o início
+    int *anterior = (int*)malloc(n * sizeof(int));
+    char *fechado = (char*)calloc(n, sizeof(char));
+    struct heapcaminho heap = {NULL, 0, 0};
+    if (!percorrida || !anterior || !fechado) {
+        free(percorrida);
+        free(anterior);
+        free(fechado);
+        corletra(RED);
+        printf("Erro ao alocar memória.\n");
+        corletra(WHITE);
+        return 0;
+    }
+    for (int v = 0; v < n; v++) {
+        percorrida[v] = INFINITY;
+        anterior[v] = -1;
+    }
+
+    percorrida[origem] = 0;
+    int semmemoria = !heap_inserir(&heap, distancia_coordenadas(linha[origem], coluna[origem], linha[destino], coluna[destino]), origem);
+    while (!semmemoria && heap.tamanho > 0) {
+        int atual = heap_remover_minimo(&heap).vertice;
+        if (fechado[atual]) continue;           /// Entrada antiga
+        fechado[atual] = 1;
+        if (atual == destino) break;
+
+        for (int vizinho = 0; vizinho < n; vizinho++) {
+            if (fechado[vizinho]) continue;
+            float ligacao = distancia_coordenadas(linha[atual], coluna[atual], linha[vizinho], coluna[vizinho]);
+            if (distanciamaxima > 0 && ligacao > distanciamaxima) continue; /// Ligação demasiado longa
+            float distancia = percorrida[atual] + ligacao;
+            if (distancia < percorrida[vizinho]) {
+                percorrida[vizinho] = distancia;
+                anterior[vizinho] = atual;
+                if (!heap_inserir(&heap, distancia + distancia_coordenadas(linha[vizinho], coluna[vizinho], linha[destino], coluna[destino]), vizinho)) {
+                    semmemoria = 1; /// Um vértice por expandir ficou fora da heap, o resultado já não seria o mais curto
+                    break;
+                }
+            }
+        }
+    }
+
+    if (semmemoria) {
+        free(heap.elementos);
+        free(percorrida);
+        free(anterior);
+        free(fechado);
+        corletra(RED);
+        printf("Erro ao alocar memória.\n");
+        corletra(WHITE);
+        return 0;
+    }
+
+    if (fechado[destino]) {
+        *distanciatotal = percorrida[destino];
+        for (int v = destino; v != -1; v = anterior[v]) { /// Reconstrói o caminho do fim para o início
+            caminho novo = (caminho)malloc(sizeof(struct caminho));
+            if (!novo) {
+                libertar_caminho(*percurso);
+                *percurso = NULL;
+                semmemoria = 1;
+                break;
+            }
+            novo->vertice = colunas->vertice[primeiro + v];
+            novo->seguinte = *percurso;
+            *percurso = novo;
+        }
+    }
+
+    free(heap.elementos);
+    free(percorrida);
+    free(anterior);
+    free(fechado);
+    if (semmemoria) {
+        corletra(RED);
+        printf("Erro ao alocar memória.\n");
+        corletra(WHITE);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Função para imprimir um caminho entre antenas.
+ * @param colunas Antenas organizadas por colunas.
+ * @param percurso Caminho a imprimir.
+ * @param distancia Comprimento total do caminho.
+ */
+void imprimir_caminho(colunasantenas colunas, caminho percurso, float distancia)
+{
+    printf("Caminho: ");
+    for (caminho c = percurso; c != NULL; c = c->seguinte) {
+        int i = colunas->indice[c->vertice];
+        printf("--> Freq: %c n %d (%d, %d) ", frequencia_da_posicao(colunas, i), c->vertice, colunas->linha[i], colunas->coluna[i]);
+    }
+    printf("\nDistância total: %.2f\n", distancia);
+}
+
+/**
+ * @brief Função para calcular o ponto de interseção entre a reta de um par de antenas e a reta do par (c, d).
+ * @param declivefuncao1 Declive da reta do primeiro par.
+ * @param bfuncao1 Ordenada na origem da reta do primeiro par.
+ * @param linhac, colunac Coordenadas da antena c.
+ * @param linhad, colunad Coordenadas da antena d.
+ * @param linhasmapa, colunasmapa Dimensões do mapa.
+ * @param xintercessao, yintercessao Ponto de interseção calculado.
+ * @return 1 se a interseção está dentro do mapa, 0 caso contrário (incluindo retas paralelas).
+ */
+int ponto_intersecao(float declivefuncao1, float bfuncao1, int linhac, int colunac, int linhad, int colunad, int linhasmapa, int colunasmapa, float *xintercessao, float *yintercessao)
+{
+    float declivefuncao2 = (float)(colunad - colunac) / (linhad - linhac); // declive em numerico (8/2 = 4)
+    float bfuncao2 = (float)colunac - declivefuncao2 * colunac;            //calculo do b da função (b = y - mx) => b = 1 - 4*6 = -23
+    //Atenção, que uma linha está guardada como x, num plano cartesiano seria y e vice versa
+    //basicamente já tenho:
+    //y1=m1x + b1, segundo o exemplo: y1= 2x + -7
+    //y2=m2x + b2, segundo o exemplo: y2= 4x + -23
+    // agora é igualar as duas funções, que dará x=(b2-b1)/(m1-m2) => 
+    //x= (-23-(-7))/(2-4) => x= -16/-2 => x=8
+    
+    // para descobrir o ponto de interseção, igualamos as duas funções:
+    *xintercessao = (bfuncao2 - bfuncao1) / (declivefuncao1 - declivefuncao2); ///calculo do x da coordenada de interseção usando a fórmula x=(b2-b1)/(m1-m2)
+    *yintercessao = declivefuncao1 * *xintercessao + bfuncao1; ///calculo do y da coordenada de interseção usando a fórmula y=mx+b
+    /// A linha e a coluna são comparadas em separado com as dimensões do mapa; um resultado infinito ou NaN
+    /// (retas paralelas) falha sempre estas comparações
+    double x = *xintercessao, y = *yintercessao;
+    return x > 0 && x <= linhasmapa && y > 0 && y <= colunasmapa;
+}
+
+/**
+ * @brief Função para encontrar, num intervalo ordenado de vértices, a primeira posição com vértice maior que o indicado.
+ * @param vertice Vetor de vértices, ordenado no intervalo [inicio, fim).
+ * @param inicio Início do intervalo.
+ * @param fim Fim do intervalo (exclusivo).
+ * @param limite Vértice de referência.
+ * @return Primeira posição com vertice[posicao] > limite, ou fim se não existir.
+ */
+int primeiro_depois(int vertice[], int inicio, int fim, int limite)
+{
+    while (inicio < fim) /// Pesquisa binária
+    {
+        int meio = inicio + (fim - inicio) / 2;
+        if (vertice[meio] <= limite)
+            inicio = meio + 1;
+        else
+            fim = meio;
+    }
+    return inicio;
+}
 
 /**
  * @brief Função para determinar se dois pares de antenas com frequências de ressonância distintas A e B se intersetam 
- * @details A função percorre a lista de antenas e verifica se as antenas A e B têm frequências diferentes e se não são a mesma antena.
+ * @details A função percorre as antenas organizadas por colunas: para cada par (a, b) de uma frequência percorre os pares (c, d)
+ * das outras frequências, com b antes de d, d antes de a e a antes de c (pela ordem dos vértices).
+ * Como as antenas de cada frequência estão seguidas e ordenadas pelo vértice, estes limites são apenas intervalos dos vetores.
  * Depois, calcula o declive e o ponto de interseção entre as duas antenas.
  * Se o ponto de interseção estiver dentro dos limites das antenas A e B, imprime a coordenada de interseção.
  * Caso sejam paralelas é imprimo uma mensagem com essa informação.
  * @bug Problemas com verificações de dados e iterações. Ajustes na lógica necessários.
- * @param mapa 
+ * @param colunas Antenas organizadas por colunas.
+ * @param linhasmapa, colunasmapa Dimensões do mapa.
  */
-void intersecao(antenas mapa, int tamanho) {
+void intersecao(colunasantenas colunas, int linhasmapa, int colunasmapa) {
     
-    int n_antenas = contarantenas(mapa);
-    for (antenas a = mapa; a != NULL; a = a->seguinte) {
-        for (antenas b = mapa; b != NULL && b != a; b = b->seguinte) {
-            if (a->freq != b->freq || a->verticeantena == b->verticeantena) continue;           /// Ignorar se são frequências diferentes ou se for a mesma antena
-            for (antenas c = a->seguinte; c != NULL && c != b; c = c->seguinte) {
-                for (antenas d = b->seguinte; d != NULL && d != a && d != c; d = d->seguinte) {
-                    if (c->freq != d->freq || c->verticeantena == d->verticeantena) continue;
-                    if (a->freq != c->freq &&
-                        a->verticeantena != c->verticeantena && a->verticeantena != d->verticeantena &&
-                        b->verticeantena != c->verticeantena && b->verticeantena != d->verticeantena) {             /// Garantir que são antenas distintas
-                        float declivefuncao1 = (float)(b->coordenadas%1000 - a->coordenadas%1000) / (b->coordenadas/1000 - a->coordenadas/1000); ///declive em numerico (4/2 = 2)
-                        float bfuncao1 = (float)(a->coordenadas % 1000) - declivefuncao1 * (a->coordenadas / 1000);  ///calculo do b da função (b = y - mx) => b = 2 - 3*3 = -7
-                        //bfuncao1 = 2x + -7
-                        float declivefuncao2 = (float)(d->coordenadas%1000 - c->coordenadas%1000) / (d->coordenadas/1000 - c->coordenadas/1000); // declive em numerico (8/2 = 4)
-                        float bfuncao2 = (float)(c->coordenadas%1000) - declivefuncao2*(c->coordenadas%1000);  //calculo do b da função (b = y - mx) => b = 1 - 4*6 = -23
-                        //Atenção, que uma linha está guardada como x, num plano cartesiano seria y e vice versa
-                        //basicamente já tenho:
-                        //y1=m1x + b1, segundo o exemplo: y1= 2x + -7
-                        //y2=m2x + b2, segundo o exemplo: y2= 4x + -23
-                        // agora é igualar as duas funções, que dará x=(b2-b1)/(m1-m2) => 
-                        //x= (-23-(-7))/(2-4) => x= -16/-2 => x=8
-                        
-                        // para descobrir o ponto de interseção, igualamos as duas funções:
-                        float xintercessao = (bfuncao2 - bfuncao1) / (declivefuncao1 - declivefuncao2); ///calculo do x da coordenada de interseção usando a fórmula x=(b2-b1)/(m1-m2)
-                        float yintercessao = declivefuncao1 * xintercessao + bfuncao1; ///calculo do y da coordenada de interseção usando a fórmula y=mx+b
-                        int coordenadasintercessao = (xintercessao * 1000) + yintercessao; ///calculo da coordenada de interseção
-                        if (coordenadasintercessao == 0) continue;
-                        if (coordenadasintercessao > 0 && coordenadasintercessao < tamanho) {
+    if (colunas == NULL) return;
+    int *linha = colunas->linha;
+    int *coluna = colunas->coluna;
+    int *vertice = colunas->vertice;
+
+    for (int fa = 0; fa < 256; fa++) {
+        for (int a = colunas->inicio[fa]; a < colunas->inicio[fa + 1]; a++) {
+            int primeiroc[256];                                                                 /// c depois de a: só depende de a e da frequência de c
+            for (int fc = 0; fc < 256; fc++) {
+                primeiroc[fc] = primeiro_depois(vertice, colunas->inicio[fc], colunas->inicio[fc + 1], vertice[a]);
+            }
+            for (int b = colunas->inicio[fa]; b < a; b++) {                                    /// b antes de a, com a mesma frequência
+                float declivefuncao1 = (float)(coluna[b] - coluna[a]) / (linha[b] - linha[a]); ///declive em numerico (4/2 = 2)
+                float bfuncao1 = (float)coluna[a] - declivefuncao1 * linha[a];                 ///calculo do b da função (b = y - mx) => b = 2 - 3*3 = -7
+                //bfuncao1 = 2x + -7
+                for (int fc = 0; fc < 256; fc++) {
+                    int fim = colunas->inicio[fc + 1];
+                    if (fc == fa || primeiroc[fc] == fim) continue;                             /// Ignorar se são frequências iguais ou se não há c
+                    int primeirod = primeiro_depois(vertice, colunas->inicio[fc], primeiroc[fc], vertice[b]); /// d depois de b e antes de a
+                    for (int c = primeiroc[fc]; c < fim; c++) {
+                        for (int d = primeirod; d < primeiroc[fc]; d++) {
+                            float xintercessao, yintercessao;
+                            if (ponto_intersecao(declivefuncao1, bfuncao1, linha[c], coluna[c], linha[d], coluna[d], linhasmapa, colunasmapa, &xintercessao, &yintercessao)) {
                                 corletra(GREEN);
-                                printf("As antenas %c(%d,%d)  %c(%d,%d) e %c(%d,%d) %c(%d,%d) interceptam-se na coordenada (%.2f, %.2f)\n", a->freq, a->coordenadas/1000, a->coordenadas%1000, b->freq, b->coordenadas/1000, b->coordenadas%1000, 
-                                    c->freq, c->coordenadas/1000, c->coordenadas%1000, d->freq, d->coordenadas/1000, d->coordenadas%1000, xintercessao, yintercessao);
+                                printf("As antenas %c(%d,%d)  %c(%d,%d) e %c(%d,%d) %c(%d,%d) interceptam-se na coordenada (%.2f, %.2f)\n", fa, linha[a], coluna[a], fa, linha[b], coluna[b], 
+                                    fc, linha[c], coluna[c], fc, linha[d], coluna[d], xintercessao, yintercessao);
                                 corletra(WHITE);
                             }
+                        }
                     }
                 }
             }
@@ -500,14 +975,32 @@ void intersecao(antenas mapa, int tamanho) {
 
 /**
  * @brief Função para adicionar adjacentes.
+ * @details As antenas da mesma frequência são todas adjacentes entre si. A organização por colunas dá, para cada
+ * frequência, o intervalo dos seus vértices por ordem, pelo que cada lista é construída de uma vez, inserindo no fim.
  * @param mapa Ponteiro para a lista de antenas.
- * @param novo Ponteiro para a lista de adjacentes.
- * 
+ * @param colunas Antenas organizadas por colunas, construídas a partir de mapa.
  */
-antenas adicionarAdjacentes(antenas mapa) {
+antenas adicionarAdjacentes(antenas mapa, colunasantenas colunas) {
+    antenas *nos = colunas ? (antenas*)malloc((colunas->total + 1) * sizeof(antenas)) : NULL; /// Antena de cada vértice
+    if (!nos) {
+        corletra(RED);
+        printf("Erro ao alocar memória para adjacente.\n");
+        corletra(WHITE);
+        return mapa;
+    }
     for (antenas a = mapa; a != NULL; a = a->seguinte) {
-        for (antenas b = mapa; b != NULL; b = b->seguinte) {
-            if (a->freq == b->freq && a->verticeantena != b->verticeantena) {
+        nos[a->verticeantena] = a;
+    }
+
+    for (int f = 0; f < 256; f++) {
+        for (int i = colunas->inicio[f]; i < colunas->inicio[f + 1]; i++) {
+            antenas a = nos[colunas->vertice[i]];
+            adjacentes fim = a->listaadjacentes;
+            while (fim != NULL && fim->seguinte != NULL) {
+                fim = fim->seguinte;
+            }
+            for (int j = colunas->inicio[f]; j < colunas->inicio[f + 1]; j++) {
+                if (j == i) continue;
                 adjacentes novo = (adjacentes)malloc(sizeof(struct adjacentes));
                 if (!novo) {
                     corletra(RED);
@@ -515,22 +1008,20 @@ antenas adicionarAdjacentes(antenas mapa) {
                     corletra(WHITE);
                     continue;
                 }
-                novo->verticeadjacente = b->verticeantena;
+                novo->verticeadjacente = colunas->vertice[j];
                 novo->seguinte = NULL;
 
                 // Inserir no fim da lista de adjacentes de 'a'
-                if (a->listaadjacentes == NULL) {
+                if (fim == NULL) {
                     a->listaadjacentes = novo;
                 } else {
-                    adjacentes temp = a->listaadjacentes;
-                    while (temp->seguinte != NULL) {
-                        temp = temp->seguinte;
-                    }
-                    temp->seguinte = novo;
+                    fim->seguinte = novo;
                 }
+                fim = novo;
             }
         }
     }
+    free(nos);
 
     corletra(GREEN);
     printf("Adjacentes adicionados com sucesso!\n");
@@ -559,6 +1050,483 @@ void imprimirAdjacentes(antenas mapa) {
     
 }
 
+/**
+ * @brief Função para criar um estado de leitura vazio, a preencher por ler_ficheiro.
+ * @return Ponteiro para o estado ou NULL em caso de erro.
+ */
+estadoleitura criar_estado_ficheiro()
+{
+    return (estadoleitura)calloc(1, sizeof(struct estadoleitura));
+}
+
+/**
+ * @brief Função para libertar a memória alocada para o estado da leitura.
+ * 
+ * @param estado 
+ */
+void libertar_estado_ficheiro(estadoleitura estado)
+{
+    if (estado == NULL)
+        return;
+    free(estado->hashlinhas);
+    free(estado);
+}
+
+/**
+ * @brief Função para recarregar o ficheiro interpretando apenas as linhas que foram alteradas.
+ * @details Compara o hash de cada linha com o da leitura anterior. Nas linhas alteradas, as antenas antigas são
+ * removidas e as novas são inseridas na mesma posição da lista, que continua por ordem de linha e coluna.
+ * No fim os vértices são renumerados pela mesma ordem de ler_ficheiro. Como a renumeração muda os números de quase
+ * todos os vértices, converter os adjacentes existentes custaria o mesmo que refazê-los, por isso as colunas e os
+ * adjacentes são reconstruídos com construir_colunas e adicionarAdjacentes (lineares no número de ligações).
+ * O que se poupa é a leitura e a inserção das linhas que não mudaram.
+ * Se as dimensões do mapa mudarem é feita uma leitura completa.
+ * @param ficheiro Nome do ficheiro.
+ * @param mapa Ponteiro para a lista de antenas já carregada.
+ * @param estado Estado da leitura anterior (é atualizado).
+ * @param porcolunas Antenas organizadas por colunas (são reconstruídas se o mapa mudar).
+ * @return Ponteiro para a lista de antenas.
+ */
+antenas recarregar_ficheiro(char ficheiro[], antenas mapa, estadoleitura estado, colunasantenas *porcolunas)
+{
+    int linhas = n_linhas(ficheiro);
+    int colunas = n_colunas(ficheiro);
+    if (linhas != estado->linhas || colunas != estado->colunas) /// Dimensões diferentes, a numeração muda toda
+    {
+        corletra(YELLOW);
+        printf("As dimensões do mapa mudaram. A ler o ficheiro completo...\n");
+        corletra(WHITE);
+        libertar_memoria_antenas(mapa);
+        mapa = ler_ficheiro(ficheiro, NULL, estado);
+        libertar_colunas(*porcolunas);
+        *porcolunas = construir_colunas(mapa);
+        return adicionarAdjacentes(mapa, *porcolunas);
+    }
+
+    FILE *cidade = fopen(ficheiro, "rb");
+    if (!cidade)
+    {
+        corletra(RED);
+        printf("Erro ao abrir o ficheiro.\n");
+        corletra(WHITE);
+        return mapa;
+    }
+    char *linha = (char*)malloc(colunas + 1);
+    if (!linha)
+    {
+        fclose(cidade);
+        corletra(RED);
+        printf("Erro ao alocar memória.\n");
+        corletra(WHITE);
+        return mapa;
+    }
+
+    int alteradas = 0;
+    antenas anterior = NULL;
+    antenas atual = mapa;
+    for (int i = 0; i < linhas; i++)
+    {
+        ler_linha_mapa(cidade, linha, colunas);
+        unsigned long hash = hash_linha(linha, colunas);
+
+        while (atual != NULL && atual->coordenadas / 1000 < i + 1) /// Avança até à linha i
+        {
+            anterior = atual;
+            atual = atual->seguinte;
+        }
+        if (hash == estado->hashlinhas[i])
+            continue;
+
+        while (atual != NULL && atual->coordenadas / 1000 == i + 1) /// Remove as antenas antigas da linha
+        {
+            antenas temp = atual;
+            atual = atual->seguinte;
+            if (anterior == NULL)
+                mapa = atual;
+            else
+                anterior->seguinte = atual;
+            liberar_memoria_adjacentes(temp->listaadjacentes);
+            free(temp);
+        }
+
+        int completa = 1;
+        for (int j = 0; j < colunas; j++) /// Insere as antenas novas da linha
+        {
+            if (linha[j] == '.')
+                continue;
+            antenas novo = (antenas)malloc(sizeof(struct antenas));
+            if (!novo)
+            {
+                corletra(RED);
+                printf("Erro ao alocar memória.\n");
+                corletra(WHITE);
+                completa = 0;
+                continue;
+            }
+            novo->verticeantena = 0; /// Numerada no fim, com as restantes
+            novo->freq = linha[j];
+            novo->coordenadas = ((i + 1) * 1000) + (j + 1);
+            novo->listaadjacentes = NULL;
+            novo->seguinte = atual;
+            if (anterior == NULL)
+                mapa = novo;
+            else
+                anterior->seguinte = novo;
+            anterior = novo;
+        }
+        if (completa) /// Se faltou alguma antena o hash antigo fica, para a linha voltar a ser lida
+            estado->hashlinhas[i] = hash;
+        alteradas++;
+    }
+    fclose(cidade);
+    free(linha);
+
+    if (alteradas == 0)
+    {
+        corletra(GREEN);
+        printf("O ficheiro não tem alterações.\n");
+        corletra(WHITE);
+        return mapa;
+    }
+
+    int contador = 1;
+    for (antenas a = mapa; a != NULL; a = a->seguinte) /// Renumera pela ordem de linha e coluna
+    {
+        liberar_memoria_adjacentes(a->listaadjacentes); /// Os adjacentes são refeitos com a nova numeração
+        a->listaadjacentes = NULL;
+        a->verticeantena = contador++;
+    }
+    libertar_colunas(*porcolunas);
+    *porcolunas = construir_colunas(mapa);
+    mapa = adicionarAdjacentes(mapa, *porcolunas);
+
+    corletra(GREEN);
+    printf("Ficheiro recarregado: %d de %d linhas voltaram a ser lidas.\n", alteradas, linhas);
+    corletra(WHITE);
+    return mapa;
+}
+
+/**
+ * @brief Função para ler um bloco de registos de uma frequência do ficheiro temporário agrupado.
+ * @param agrupado Ficheiro temporário com os registos agrupados por frequência.
+ * @param resumo Resumo da frequência.
+ * @param indice Índice do primeiro registo a ler dentro da frequência.
+ * @param bloco Vetor onde são guardados os registos.
+ * @param tamanhobloco Número máximo de registos a ler.
+ * @return Número de registos lidos, ou -1 se o ficheiro não pôde ser lido.
+ */
+long long ler_bloco_frequencia(FILE *agrupado, resumofrequencia *resumo, long long indice, registoantena bloco[], long long tamanhobloco)
+{
+    long long quantidade = resumo->quantidade - indice;
+    if (quantidade > tamanhobloco)
+        quantidade = tamanhobloco;
+    if (quantidade <= 0)
+        return 0;
+    long long deslocamento = (resumo->inicio + indice) * (long long)sizeof(registoantena);
+    if (fseek64(agrupado, deslocamento, SEEK_SET) != 0 ||
+        (long long)fread(bloco, sizeof(registoantena), quantidade, agrupado) != quantidade)
+    {
+        corletra(RED);
+        printf("Erro ao ler o ficheiro temporário.\n");
+        corletra(WHITE);
+        return -1;
+    }
+    return quantidade;
+}
+
+/**
+ * @brief Função para escrever os registos de uma frequência na sua posição do ficheiro temporário agrupado.
+ * @param agrupado Ficheiro temporário com os registos agrupados por frequência.
+ * @param resumo Resumo da frequência.
+ * @param escritos Número de registos da frequência já escritos.
+ * @param balde Registos a escrever.
+ * @param quantidade Número de registos a escrever.
+ * @return 1 se foram escritos, 0 em caso de erro.
+ */
+int despejar_balde(FILE *agrupado, resumofrequencia *resumo, long long escritos, registoantena balde[], long long quantidade)
+{
+    long long deslocamento = (resumo->inicio + escritos) * (long long)sizeof(registoantena);
+    return fseek64(agrupado, deslocamento, SEEK_SET) == 0 &&
+        (long long)fwrite(balde, sizeof(registoantena), quantidade, agrupado) == quantidade;
+}
+
+/**
+ * @brief Função para determinar as interseções lendo os pares de antenas aos blocos do ficheiro temporário.
+ * @details Usa os mesmos critérios de intersecao (b antes de d, d antes de a e a antes de c, pela ordem dos vértices),
+ * mas em vez de ter todas as antenas em memória percorre combinações de quatro blocos: A e B da frequência
+ * de a e b, C e D da frequência de c e d. Os blocos em que nenhuma antena cumpre a ordem dos vértices são ignorados.
+ * @param agrupado Ficheiro temporário com os registos agrupados por frequência.
+ * @param resumo Resumo de cada frequência.
+ * @param blocos Quatro vetores com tamanhobloco registos cada.
+ * @param tamanhobloco Número de registos de cada bloco.
+ * @param linhasmapa, colunasmapa Dimensões do mapa.
+ * @return Número de interseções encontradas, ou -1 se o ficheiro temporário não pôde ser lido.
+ */
+long long intersecao_por_blocos(FILE *agrupado, resumofrequencia resumo[], registoantena *blocos[4], long long tamanhobloco, int linhasmapa, int colunasmapa)
+{
+    long long encontradas = 0;
+    registoantena *A = blocos[0], *B = blocos[1], *C = blocos[2], *D = blocos[3];
+    for (int fa = 0; fa < 256; fa++) {
+        for (long long ia = 0; ia < resumo[fa].quantidade; ia += tamanhobloco) {
+            long long na = ler_bloco_frequencia(agrupado, &resumo[fa], ia, A, tamanhobloco);
+            if (na < 0) return -1;
+            for (long long ib = 0; ib <= ia; ib += tamanhobloco) {                       /// b antes de a: blocos até ao de a
+                long long nb = ler_bloco_frequencia(agrupado, &resumo[fa], ib, B, tamanhobloco);
+                if (nb < 0) return -1;
+                for (int fc = 0; fc < 256; fc++) {
+                    if (fc == fa || resumo[fc].quantidade == 0) continue;         /// Ignorar se são frequências iguais
+                    for (long long ic = 0; ic < resumo[fc].quantidade; ic += tamanhobloco) {
+                        long long nc = ler_bloco_frequencia(agrupado, &resumo[fc], ic, C, tamanhobloco);
+                        if (nc < 0) return -1;
+                        if (nc == 0 || C[nc - 1].vertice < A[0].vertice) continue; /// Nenhum c depois de a
+                        for (long long id = 0; id <= ic; id += tamanhobloco) {           /// d antes de a e portanto antes de c
+                            long long nd = ler_bloco_frequencia(agrupado, &resumo[fc], id, D, tamanhobloco);
+                            if (nd < 0) return -1;
+                            if (nd == 0 || D[0].vertice > A[na - 1].vertice) break; /// Nenhum d antes de a
+                            if (D[nd - 1].vertice < B[0].vertice) continue;          /// Nenhum d depois de b
+
+                            for (long long a = 0; a < na; a++) {
+                                for (long long b = 0; b < nb && B[b].vertice < A[a].vertice; b++) {
+                                    float declivefuncao1 = (float)(B[b].coluna - A[a].coluna) / (B[b].linha - A[a].linha);
+                                    float bfuncao1 = (float)A[a].coluna - declivefuncao1 * A[a].linha;
+                                    for (long long c = 0; c < nc; c++) {
+                                        if (C[c].vertice < A[a].vertice) continue;
+                                        for (long long d = 0; d < nd && D[d].vertice < A[a].vertice; d++) {
+                                            if (D[d].vertice < B[b].vertice) continue;
+                                            float xintercessao, yintercessao;
+                                            if (ponto_intersecao(declivefuncao1, bfuncao1, C[c].linha, C[c].coluna, D[d].linha, D[d].coluna, linhasmapa, colunasmapa, &xintercessao, &yintercessao)) {
+                                                corletra(GREEN);
+                                                printf("As antenas %c(%d,%d)  %c(%d,%d) e %c(%d,%d) %c(%d,%d) interceptam-se na coordenada (%.2f, %.2f)\n", A[a].freq, A[a].linha, A[a].coluna, B[b].freq, B[b].linha, B[b].coluna, 
+                                                    C[c].freq, C[c].linha, C[c].coluna, D[d].freq, D[d].linha, D[d].coluna, xintercessao, yintercessao);
+                                                corletra(WHITE);
+                                                encontradas++;
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return encontradas;
+}
+
+/**
+ * @brief Função para analisar um ficheiro sem o carregar todo para memória.
+ * @details O ficheiro é lido em faixas horizontais de linhas. Cada antena encontrada é escrita num ficheiro temporário
+ * e em memória fica apenas o resumo de cada frequência. Depois os registos são agrupados por frequência num segundo
+ * ficheiro temporário, numa única passagem, a partir do qual são feitas a contagem, a conetividade e as interseções.
+ * Metade do limite de memória é usada para a faixa de linhas e a outra metade para os quatro blocos de registos.
+ * Um limite que não chegue para uma linha do mapa e para os blocos é recusado, em vez de ser ultrapassado.
+ * O resumo por frequência e os buffers internos dos ficheiros não contam para o limite.
+ * Os vértices são numerados pela mesma ordem de ler_ficheiro.
+ * @param ficheiro Nome do ficheiro.
+ * @param limitememoria Memória máxima, em bytes, para a faixa de linhas e os blocos de registos.
+ */
+void analise_por_faixas(char ficheiro[], long long limitememoria)
+{
+    int linhas = n_linhas(ficheiro);
+    int colunas = n_colunas(ficheiro);
+    FILE *cidade = fopen(ficheiro, "rb");
+    if (!cidade || colunas == 0)
+    {
+        if (cidade) fclose(cidade);
+        corletra(RED);
+        printf("Erro ao abrir o ficheiro.\n");
+        corletra(WHITE);
+        return;
+    }
+
+    /// Metade do limite tem de levar pelo menos uma linha do mapa e a outra metade blocos com espaço para
+    /// agrupar as 256 frequências possíveis (os blocos 1 a 3 são divididos entre elas)
+    long long minimo = 4 * ((256 + 2) / 3) * (long long)sizeof(registoantena);
+    if (colunas > minimo) minimo = colunas;
+    minimo *= 2;
+    if (limitememoria < minimo)
+    {
+        fclose(cidade);
+        corletra(RED);
+        printf("Limite de memória demasiado pequeno para este mapa. O mínimo é %lld KB.\n", (minimo + 1023) / 1024);
+        corletra(WHITE);
+        return;
+    }
+    long long linhasfaixa = (limitememoria / 2) / colunas;
+    if (linhasfaixa > linhas) linhasfaixa = linhas;
+    long long tamanhobloco = (limitememoria / 2) / (4 * (long long)sizeof(registoantena));
+
+    char *faixa = (char*)malloc(linhasfaixa * colunas);
+    registoantena *memoria = (registoantena*)malloc(4 * tamanhobloco * sizeof(registoantena)); /// Os quatro blocos seguidos
+    registoantena *blocos[4];
+    for (int k = 0; k < 4; k++)
+        blocos[k] = memoria + k * tamanhobloco;
+    FILE *temporario = tmpfile();  /// Registos pela ordem de leitura
+    FILE *agrupado = tmpfile();    /// Registos agrupados por frequência
+    if (!faixa || !memoria || !temporario || !agrupado)
+    {
+        corletra(RED);
+        printf("Erro ao alocar memória ou ao criar os ficheiros temporários.\n");
+        corletra(WHITE);
+        fclose(cidade);
+        if (temporario) fclose(temporario);
+        if (agrupado) fclose(agrupado);
+        free(faixa);
+        free(memoria);
+        return;
+    }
+
+    resumofrequencia resumo[256];
+    for (int f = 0; f < 256; f++)
+    {
+        resumo[f].quantidade = 0;
+        resumo[f].inicio = 0;
+    }
+
+    long long contador = 1;
+    long long faixas = 0;
+    for (int primeira = 0; primeira < linhas; primeira += linhasfaixa) /// Lê o mapa faixa a faixa
+    {
+        int nlinhas = (linhas - primeira < linhasfaixa) ? linhas - primeira : (int)linhasfaixa;
+        for (int i = 0; i < nlinhas; i++)
+            ler_linha_mapa(cidade, faixa + (long long)i * colunas, colunas);
+
+        for (int i = 0; i < nlinhas; i++)
+        {
+            for (int j = 0; j < colunas; j++)
+            {
+                char freq = faixa[(long long)i * colunas + j];
+                if (freq == '.')
+                    continue;
+                registoantena registo;
+                registo.freq = freq;
+                registo.linha = primeira + i + 1;
+                registo.coluna = j + 1;
+                registo.vertice = contador++;
+                if (fwrite(&registo, sizeof(registoantena), 1, temporario) != 1) /// Disco temporário cheio
+                {
+                    corletra(RED);
+                    printf("Erro ao escrever no ficheiro temporário. Análise interrompida.\n");
+                    corletra(WHITE);
+                    fclose(cidade);
+                    fclose(temporario);
+                    fclose(agrupado);
+                    free(faixa);
+                    free(memoria);
+                    return;
+                }
+
+                resumofrequencia *r = &resumo[(unsigned char)freq];
+                if (r->quantidade == 0)
+                {
+                    r->linhamin = r->linhamax = registo.linha;
+                    r->colunamin = r->colunamax = registo.coluna;
+                }
+                if (registo.linha > r->linhamax) r->linhamax = registo.linha;  /// As linhas só aumentam
+                if (registo.coluna < r->colunamin) r->colunamin = registo.coluna;
+                if (registo.coluna > r->colunamax) r->colunamax = registo.coluna;
+                r->quantidade++;
+            }
+        }
+        faixas++;
+    }
+    fclose(cidade);
+    free(faixa);
+
+    /// Agrupa os registos por frequência numa única passagem: o bloco 0 recebe os registos lidos e os blocos 1 a 3
+    /// são divididos entre as frequências presentes, cada uma escrita na sua posição quando o seu espaço enche
+    long long posicao = 0;
+    int presentes = 0;
+    for (int f = 0; f < 256; f++)
+    {
+        if (resumo[f].quantidade == 0)
+            continue;
+        resumo[f].inicio = posicao;
+        posicao += resumo[f].quantidade;
+        presentes++;
+    }
+    long long porfrequencia = presentes > 0 ? (3 * tamanhobloco) / presentes : 1; /// Pelo menos 1, garantido pelo limite mínimo
+
+    registoantena *baldes[256];
+    long long pendentes[256];
+    long long escritos[256];
+    int proximo = 0;
+    for (int f = 0; f < 256; f++)
+    {
+        pendentes[f] = 0;
+        escritos[f] = 0;
+        baldes[f] = (resumo[f].quantidade > 0) ? blocos[1] + (proximo++) * porfrequencia : NULL;
+    }
+
+    int erro = (fflush(temporario) != 0); /// Falhas de escrita que só aparecem ao despejar o buffer
+    long long lidostotal = 0;
+    size_t lidos;
+    rewind(temporario);
+    while (!erro && (lidos = fread(blocos[0], sizeof(registoantena), tamanhobloco, temporario)) > 0)
+    {
+        lidostotal += lidos;
+        for (size_t k = 0; k < lidos && !erro; k++)
+        {
+            int f = (unsigned char)blocos[0][k].freq;
+            baldes[f][pendentes[f]++] = blocos[0][k];
+            if (pendentes[f] == porfrequencia)
+            {
+                erro = !despejar_balde(agrupado, &resumo[f], escritos[f], baldes[f], pendentes[f]);
+                escritos[f] += pendentes[f];
+                pendentes[f] = 0;
+            }
+        }
+    }
+    for (int f = 0; f < 256 && !erro; f++) /// Escreve o que ficou em cada frequência
+    {
+        if (pendentes[f] > 0)
+            erro = !despejar_balde(agrupado, &resumo[f], escritos[f], baldes[f], pendentes[f]);
+    }
+    if (!erro && (ferror(temporario) || lidostotal != contador - 1))
+        erro = 1;
+    fclose(temporario);
+    if (erro || fflush(agrupado) != 0)
+    {
+        corletra(RED);
+        printf("Erro ao agrupar os registos nos ficheiros temporários. Análise interrompida.\n");
+        corletra(WHITE);
+        fclose(agrupado);
+        free(memoria);
+        return;
+    }
+
+    corletra(GREEN);
+    printf("\n***************************\n");
+    corletra(WHITE);
+    printf("Mapa com %d linhas e %d colunas lido em %lld faixas de %lld linhas.\n", linhas, colunas, faixas, linhasfaixa);
+    printf("Total de antenas: %lld\n", contador - 1);
+    for (int f = 0; f < 256; f++)
+    {
+        if (resumo[f].quantidade == 0)
+            continue;
+        long long q = resumo[f].quantidade;
+        /// Todas as antenas da mesma frequência são adjacentes entre si, por isso formam uma única componente
+        printf("Frequência %c: %lld antenas, %lld ligações, 1 componente, entre (%d, %d) e (%d, %d)\n", f, q, q * (q - 1) / 2,
+            resumo[f].linhamin, resumo[f].colunamin, resumo[f].linhamax, resumo[f].colunamax);
+    }
+    corletra(GREEN);
+    printf("\n***************************\n");
+    corletra(WHITE);
+
+    long long encontradas = intersecao_por_blocos(agrupado, resumo, blocos, tamanhobloco, linhas, colunas);
+    if (encontradas < 0)
+    {
+        corletra(RED);
+        printf("Análise das interseções interrompida.\n");
+        corletra(WHITE);
+    }
+    else printf("Interseções encontradas: %lld\n", encontradas);
+
+    fclose(agrupado);
+    free(memoria);
+}
+
 /**
  * @brief Função principal do sistema.
  * @return 0 se o programa terminar com sucesso.
@@ -575,7 +1543,7 @@ int sistema()
         antenas mapaantenas = NULL; /// Inicializa a lista de antenas como vazia
         adjacentes listaadjacentes = NULL; /// Inicializa a lista de adjacentes como vazia
         adjacentes grafo = NULL; /// Inicializa o grafo como vazio
-        printf("Insira o nome do ficheiro com a extensão ou \"sair\" para encerrar o programa: ");
+        printf("Insira o nome do ficheiro com a extensão, \"faixas\" para analisar um mapa grande com memória limitada ou \"sair\" para encerrar o programa: ");
         scanf(" %s", nome_ficheiro1);
         if (strcmp(nome_ficheiro1, "sair") == 0) {
             corletra(RED);
@@ -584,6 +1552,26 @@ int sistema()
             Sleep(2000);
             return 0;
         } 
+        else if (strcmp(nome_ficheiro1, "faixas") == 0)
+        {
+            long long limite;
+            printf("Insira o nome do ficheiro com a extensão: ");
+            scanf(" %s", nome_ficheiro1);
+            printf("Insira o limite de memória em KB: ");
+            scanf(" %lld", &limite);
+            if (n_colunas(nome_ficheiro1) == 0) {
+                corletra(RED);
+                printf("Erro: ficheiro vazio, inexistente ou formato inválido.\n");
+                corletra(WHITE);
+            }
+            else if (limite <= 0) {
+                corletra(RED);
+                printf("Limite de memória inválido.\n");
+                corletra(WHITE);
+            }
+            else analise_por_faixas(nome_ficheiro1, limite * 1024LL);
+            continue;
+        }
         else if (n_colunas(nome_ficheiro1) == 0 && n_linhas(nome_ficheiro1) == 0)
         {
             corletra(RED);
@@ -594,9 +1582,12 @@ int sistema()
         else
         {
 
-            mapaantenas = ler_ficheiro(nome_ficheiro1, mapaantenas); /// Lê o ficheiro e armazena os dados na lista de antenas
-            mapaantenas = adicionarAdjacentes(mapaantenas); /// Adiciona os adjacentes à lista de antenas
-            int tamanho = n_linhas(nome_ficheiro1) * 1000 + n_colunas(nome_ficheiro1); 
+            estadoleitura estado = criar_estado_ficheiro(); /// Guarda o hash de cada linha para recarregar mais tarde
+            mapaantenas = ler_ficheiro(nome_ficheiro1, mapaantenas, estado); /// Lê o ficheiro e armazena os dados na lista de antenas
+            colunasantenas colunas = construir_colunas(mapaantenas); /// Organiza as antenas por frequência em vetores contíguos
+            mapaantenas = adicionarAdjacentes(mapaantenas, colunas); /// Adiciona os adjacentes à lista de antenas
+            int linhasmapa = n_linhas(nome_ficheiro1);
+            int colunasmapa = n_colunas(nome_ficheiro1);
             int opc;
             do
             {
@@ -606,9 +1597,10 @@ int sistema()
                 printf("1--> Ver mapa de antenas.\n");
                 printf("2--> Procura em profundidade.\n");
                 printf("3--> Procura em largura.\n");
-                printf("4--> Traçar um caminho.\n");
+                printf("4--> Traçar o caminho mais curto.\n");
                 printf("5--> Ver adjacentes.\n");
                 printf("6--> Ver pares que se intersetam.\n");
+                printf("7--> Recarregar o ficheiro (apenas linhas alteradas).\n");
                 printf("0--> Escolher outro ficheiro!\n");
                 corletra(WHITE);
                 printf("Escolha uma opção: ");
@@ -643,24 +1635,55 @@ int sistema()
                         }
                         break;
                     case 4:
-                        // int a, b;
-                        // printf("Insira o número da antena de partida: ");
-                        // scanf("%d", &a);
-                        // printf("Insira o número da antena de chegada: ");
-                        // scanf("%d", &b);
-                        // caminho_apb(mapaantenas, &grafo, &a, a, b, NULL, 0);
-                        // break;
-                        printf("Função ainda não implementada.\n");
+                        int inicio, fim;
+                        float distanciamaxima, distanciatotal;
+                        printf("Insira o número da antena de partida: ");
+                        scanf(" %d", &inicio);
+                        printf("Insira o número da antena de chegada: ");
+                        scanf(" %d", &fim);
+                        printf("Insira a distância máxima de cada ligação (0 para sem limite): ");
+                        scanf(" %f", &distanciamaxima);
+                        if (colunas == NULL || inicio < 1 || inicio > colunas->total || fim < 1 || fim > colunas->total) {
+                            corletra(RED);
+                            printf("Antena não existe.\n");
+                            corletra(WHITE);
+                            break;
+                        }
+                        caminho percurso;
+                        if (!caminho_mais_curto(colunas, inicio, fim, distanciamaxima, &percurso, &distanciatotal))
+                            break; /// O erro já foi indicado
+                        if (percurso == NULL) {
+                            corletra(RED);
+                            printf("Não existe caminho entre as antenas %d e %d.\n", inicio, fim);
+                            corletra(WHITE);
+                            break;
+                        }
+                        imprimir_caminho(colunas, percurso, distanciatotal);
+                        libertar_caminho(percurso);
+                        break;
                     case 5: 
                         imprimirAdjacentes(mapaantenas);
                         break;
                     case 6:
-                        intersecao(mapaantenas, tamanho);
+                        intersecao(colunas, linhasmapa, colunasmapa);
                         break; 
+                    case 7:
+                        if (estado == NULL) {
+                            corletra(RED);
+                            printf("Não foi possível guardar o estado da leitura anterior.\n");
+                            corletra(WHITE);
+                            break;
+                        }
+                        mapaantenas = recarregar_ficheiro(nome_ficheiro1, mapaantenas, estado, &colunas);
+                        linhasmapa = n_linhas(nome_ficheiro1);
+                        colunasmapa = n_colunas(nome_ficheiro1);
+                        break;
                     case 0:
                         corletra(BLUE);
                         liberar_memoria_adjacentes(listaadjacentes); /// Liberta a memória da lista de adjacentes
                         libertar_memoria_antenas(mapaantenas); /// Liberta a memória da lista de antenas
+                        libertar_estado_ficheiro(estado); /// Liberta o estado da leitura
+                        libertar_colunas(colunas); /// Liberta a organização por colunas
                         nome_ficheiro1[0] = '\0'; /// Limpa o nome do ficheiro
                         printf("Aguarde...\n");
                         printf("A ser redirecionado para o início...\n");